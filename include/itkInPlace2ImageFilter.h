@@ -97,6 +97,16 @@ public:
    * subclasses to fine tune its behavior. */
   virtual bool CanRunInPlace() const;
 
+  /** Can the filter run in place when the input's buffered region is
+   * larger than the output's requested region? If so, the whole input
+   * buffer is grafted to the output, while the output's requested
+   * region is kept, and the filter must only modify the requested
+   * region of the output. The data outside of the requested region
+   * remains available, to be used as a boundary. By default this is
+   * false, and the buffered region of the input must match the
+   * requested region of the output to run in place. */
+  virtual bool CanRunInPlaceOnSubRegion() const;
+
 protected:
   InPlace2ImageFilter();
   ~InPlace2ImageFilter();
@@ -131,6 +141,16 @@ protected:
    * \sa ProcessObject::ReleaseInputs() */
   virtual void ReleaseInputs();
 
+  /** Allocate the outputs when the filter is not running in place,
+   * called from AllocateOutputs(). By default the buffered region of
+   * each output is set to its requested region. Subclasses which need
+   * a larger output buffer can override this method, so the output is
+   * allocated only once. */
+  virtual void AllocateOutputsNotInPlace()
+  {
+    this->Superclass::AllocateOutputs();
+  }
+
   /** This methods should only be called during the GenerateData phase
    *  of the pipeline. This method return true if the input image's
    *  bulk data is the same as the output image's data.
@@ -145,7 +165,7 @@ private:
   void InternalAllocateOutputs( const FalseType& )
   {
     this->m_RunningInPlace = false;
-    this->Superclass::AllocateOutputs();
+    this->AllocateOutputsNotInPlace();
   }
 
   void InternalAllocateOutputs( const TrueType& );
@@ -61,10 +61,20 @@ InPlace2ImageFilter< TInputImage, TOutputImage, TSuperClass >
     {
     os << indent << "The input and output to this filter are the same type. The filter can be run in place."
        << std::endl;
+    if ( this->CanRunInPlaceOnSubRegion() )
+      {
+      os << indent << "The filter can be run in place on a sub-region of the input's buffered region."
+         << std::endl;
+      }
+    else
+      {
+      os << indent << "The filter can only be run in place when the input's buffered region matches the output's requested region."
+         << std::endl;
+      }
     }
   else
     {
-    os << indent << "The input and output to this filter are different types. The filter cannot be run in place."
+    os << indent << "The filter cannot be run in place."
        << std::endl;
     }
 }
@@ -79,8 +89,10 @@ InPlace2ImageFilter< TInputImage, TOutputImage, TSuperClass >
 
   // if told to run in place and the types support it,
   // additionally the buffered and requested regions of the input and
-  // output must match.
+  // output must match, or if supported the requested region of the
+  // output must be inside the buffered region of the input.
   bool rMatch = true;
+  bool rInside = true;
   if( inputPtr != NULL && (unsigned int)InputImageDimension == (unsigned int)OutputImageDimension )
     {
     for( unsigned int i=0; i<(unsigned int)InputImageDimension; i++ )
@@ -94,15 +106,21 @@ InPlace2ImageFilter< TInputImage, TOutputImage, TSuperClass >
         rMatch = false;
         }
       }
+    rInside = inputPtr->GetBufferedRegion().IsInside( outputPtr->GetRequestedRegion() );
     }
   else
     {
     rMatch = false;
+    rInside = false;
     }
   if ( this->GetInPlace() &&
        this->CanRunInPlace() &&
-       rMatch )
+       ( rMatch || ( rInside && this->CanRunInPlaceOnSubRegion() ) ) )
     {
+    // Grafting replaces the output's regions with the input's, the
+    // requested region of the output needs to be kept.
+    const OutputImageRegionType outputRequestedRegion = outputPtr->GetRequestedRegion();
+
     // Graft this first input to the output.  Later, we'll need to
     // remove the input's hold on the bulk data.
     //
@@ -114,6 +132,7 @@ InPlace2ImageFilter< TInputImage, TOutputImage, TSuperClass >
     itkAssertOrThrowMacro( inputAsOutput.IsNotNull(), "Unable to convert input image to output image as expected!" );
 
     this->GraftOutput(inputAsOutput);
+    this->GetOutput()->SetRequestedRegion(outputRequestedRegion);
     this->m_RunningInPlace = true;
 
     typedef ImageBase< OutputImageDimension > ImageBaseType;
@@ -141,7 +160,7 @@ InPlace2ImageFilter< TInputImage, TOutputImage, TSuperClass >
   else
     {
     this->m_RunningInPlace = false;
-    Superclass::AllocateOutputs();
+    this->AllocateOutputsNotInPlace();
     }
 }
 
@@ -153,6 +172,14 @@ InPlace2ImageFilter< TInputImage, TOutputImage, TSuperClass >
   return IsSame<TInputImage,TOutputImage>();
 }
 
+template< class TInputImage, class TOutputImage, class TSuperClass >
+bool
+InPlace2ImageFilter< TInputImage, TOutputImage, TSuperClass >
+::CanRunInPlaceOnSubRegion() const
+{
+  return false;
+}
+
 template< class TInputImage, class TOutputImage, class TSuperClass >
 void
 InPlace2ImageFilter< TInputImage, TOutputImage, TSuperClass >
@@ -35,7 +35,7 @@ void
 SeparableBinaryDilateImageFilter< TInputImage, TOutputImage, TKernel >
 ::FilterDataArray(OutputPixelType *outs, unsigned int ln, unsigned int radius)
   {
-    assert( radius =< 16 );
+    assert( radius <= 16 );
     const OutputPixelType foreground = this->m_ForegroundValue;
     const size_t          usedBits = sizeof(uint32_t)*8-2*radius;
     const uint32_t        new_bit = uint32_t(1)<<usedBits;
@@ -35,7 +35,7 @@ void
 SeparableBinaryErodeImageFilter< TInputImage, TOutputImage, TKernel >
 ::FilterDataArray(OutputPixelType *outs, unsigned int ln, unsigned int radius)
   {
-    assert( radius =< 16 );
+    assert( radius <= 16 );
     const OutputPixelType foreground = this->m_ForegroundValue;
     const OutputPixelType background = this->m_BackgroundValue;
     const size_t          usedBits = sizeof(uint32_t)*8-2*radius;
@@ -21,6 +21,7 @@
 #include "itkBinaryMorphologyBaseImageFilter.h"
 #include "itkInPlace2ImageFilter.h"
 #include "itkNumericTraits.h"
+#include <vector>
 
 namespace itk
 {
@@ -76,6 +77,45 @@ public:
     this->Superclass::SetKernel( kernel );
   }
 
+  /** Enable NUMA aware processing. When on, the filter does not run
+   * in place, so the output is newly allocated and first touched by
+   * the worker threads, while copying the input in the first pass.
+   * Each page is then placed on the node of the thread which
+   * processes it. Every pass splits the output on the same partition
+   * axis, and each thread id is pinned to the same processor in all
+   * of the passes, so these passes work on local memory.
+   *
+   * The pass along the partition axis cannot be split on it, and is
+   * split on the outermost axis instead, so that pass still works
+   * across nodes. Only which pass is cross-node changes: by default
+   * it is the pass along the outermost axis (z in 3D), with NUMAAware
+   * it is the pass along the partition axis (y in 3D). For 2D images
+   * the partition is the same as the default.
+   *
+   * Thread pinning is only supported on Linux, and each thread's
+   * affinity is restored when it finishes its piece. Defaults to
+   * off. */
+  itkSetMacro(NUMAAware, bool);
+  itkGetConstMacro(NUMAAware, bool);
+  itkBooleanMacro(NUMAAware);
+
+  /** The filter can not run in place when NUMAAware is on, as the
+   * pages of the input were placed by the upstream filter. */
+  virtual bool CanRunInPlace() const
+  {
+    return !this->m_NUMAAware && this->Superclass::CanRunInPlace();
+  }
+
+  /** The filter only modifies the output's requested region, and
+   * reads the halo needed from the buffered data surrounding it. So
+   * when the input buffer is larger than the requested region, the
+   * filter can still run in place on just that sub-region, and the
+   * rest of the buffer is left untouched. */
+  virtual bool CanRunInPlaceOnSubRegion() const
+  {
+    return this->CanRunInPlace();
+  }
+
 protected:
   SeparableBinaryMorphologyImageFilter();
   // virtual ~SeparableBinaryMorphologyImageFilter() {} default implementation OK
@@ -83,6 +123,14 @@ protected:
 
   virtual void VerifyPreconditions();
 
+  /** When not running in place, the output is buffered with the halo
+   * of the kernel radius around the requested region, cropped to the
+   * input's buffered region. The passes read the halo as boundary, so
+   * a sub-region gives the same result as when running in place. The
+   * pixels of the output buffer outside of the requested region are
+   * those of the input. */
+  virtual void AllocateOutputsNotInPlace();
+
   virtual void GenerateData();
 
   virtual void ThreadedGenerateData(const OutputImageRegionType & outputRegionForThread, ThreadIdType threadId);
@@ -94,6 +142,32 @@ protected:
    * the input and the output. ln is the size of the array. */
   virtual void FilterDataArray(OutputPixelType *outs, unsigned int ln, unsigned int radius) = 0;
 
+  /** The axis on which the output is partitioned between threads
+   * when NUMAAware is on. With three or more dimensions this is the
+   * second outermost axis, so that the pass along the outermost axis,
+   * which has the largest stride, works on local memory. */
+  unsigned int GetNUMAPartitionAxis() const;
+
+  /** Pin the calling thread to a processor determined by the thread
+   * id, so that the same thread id runs on the same processor in
+   * every pass. The caller is responsible for restoring the thread's
+   * affinity. */
+  void PinThreadToProcessor(ThreadIdType threadId);
+
+  /** The region processed by the pass in the direction. When the
+   * output's buffered region is larger than its requested region,
+   * this is the requested region padded by the radius along the
+   * directions of the later passes, which need these pixels as
+   * boundary. */
+  OutputImageRegionType GetPassRegion(unsigned int direction) const;
+
+  /** Split the part of outer which is outside of inner into disjoint
+   * slabs, one before and one after inner along each direction. Inner
+   * must be inside of outer. */
+  void SplitOutsideRegion(const OutputImageRegionType & outer,
+                          const OutputImageRegionType & inner,
+                          std::vector< OutputImageRegionType > & slabs) const;
+
 private:
   SeparableBinaryMorphologyImageFilter(const Self &); //purposely not implemented
   void operator=(const Self &);                //purposely not implemented
@@ -102,6 +176,16 @@ private:
    *  which should be in the range [0,ImageDimension-1]. */
   unsigned int m_Direction;
 
+  /** The region being processed by the current pass. */
+  OutputImageRegionType m_PassRegion;
+
+  bool m_NUMAAware;
+
+  /** The processors available to the calling thread, recorded at
+   * the beginning of GenerateData when NUMAAware is on, and empty
+   * otherwise. */
+  std::vector< unsigned int > m_ProcessorIds;
+
 };
 } // end namespace itk
 
@@ -23,6 +23,10 @@
 #include "itkImageAlgorithm.h"
 #include "itkProgressReporter.h"
 
+#if defined( __linux__ )
+#include <sched.h>
+#endif
+
 namespace itk
 {
 template< class TInputImage, class TOutputImage, class TKernel >
@@ -30,6 +34,118 @@ SeparableBinaryMorphologyImageFilter< TInputImage, TOutputImage, TKernel >
 ::SeparableBinaryMorphologyImageFilter()
 {
   this->m_Direction = 0;
+  this->m_NUMAAware = false;
+}
+
+template< class TInputImage, class TOutputImage, class TKernel >
+unsigned int
+SeparableBinaryMorphologyImageFilter< TInputImage, TOutputImage, TKernel >
+::GetNUMAPartitionAxis() const
+{
+  if ( TOutputImage::ImageDimension > 2 )
+    {
+    return TOutputImage::ImageDimension - 2;
+    }
+  return TOutputImage::ImageDimension - 1;
+}
+
+template< class TInputImage, class TOutputImage, class TKernel >
+void
+SeparableBinaryMorphologyImageFilter< TInputImage, TOutputImage, TKernel >
+::PinThreadToProcessor(ThreadIdType threadId)
+{
+#if defined( __linux__ )
+  if ( this->m_ProcessorIds.empty() )
+    {
+    return;
+    }
+
+  // spread the threads evenly over the available processors, the
+  // locality comes from a thread id being pinned to the same
+  // processor in every pass, not from the topology of the processors
+  const ThreadIdType numberOfThreads = this->GetMultiThreader()->GetNumberOfThreads();
+  const size_t p = ( static_cast< size_t >( threadId ) * this->m_ProcessorIds.size() ) / numberOfThreads;
+
+  cpu_set_t cpuSet;
+  CPU_ZERO(&cpuSet);
+  CPU_SET(this->m_ProcessorIds[p % this->m_ProcessorIds.size()], &cpuSet);
+  if ( sched_setaffinity( 0, sizeof( cpuSet ), &cpuSet ) != 0 )
+    {
+    itkDebugMacro("  Unable to pin thread " << threadId);
+    }
+#else
+  (void)threadId;
+#endif
+}
+
+template< class TInputImage, class TOutputImage, class TKernel >
+typename SeparableBinaryMorphologyImageFilter< TInputImage, TOutputImage, TKernel >::OutputImageRegionType
+SeparableBinaryMorphologyImageFilter< TInputImage, TOutputImage, TKernel >
+::GetPassRegion(unsigned int direction) const
+{
+  const OutputImageType *outputPtr = this->GetOutput();
+
+  typename TOutputImage::SizeType radius;
+  radius.Fill( 0 );
+  for ( unsigned int d = direction + 1; d < TOutputImage::ImageDimension; ++d )
+    {
+    radius[d] = this->m_Kernel.GetRadius( d );
+    }
+
+  OutputImageRegionType region = outputPtr->GetRequestedRegion();
+  region.PadByRadius( radius );
+  region.Crop( outputPtr->GetBufferedRegion() );
+  return region;
+}
+
+template< class TInputImage, class TOutputImage, class TKernel >
+void
+SeparableBinaryMorphologyImageFilter< TInputImage, TOutputImage, TKernel >
+::SplitOutsideRegion(const OutputImageRegionType & outer,
+                     const OutputImageRegionType & inner,
+                     std::vector< OutputImageRegionType > & slabs) const
+{
+  slabs.clear();
+
+  OutputImageRegionType remaining = outer;
+  for ( unsigned int d = 0; d < TOutputImage::ImageDimension; ++d )
+    {
+    const IndexValueType remainingEnd = remaining.GetIndex( d ) + static_cast< IndexValueType >( remaining.GetSize( d ) );
+    const IndexValueType innerEnd = inner.GetIndex( d ) + static_cast< IndexValueType >( inner.GetSize( d ) );
+
+    if ( inner.GetIndex( d ) > remaining.GetIndex( d ) )
+      {
+      OutputImageRegionType slab = remaining;
+      slab.SetSize( d, inner.GetIndex( d ) - remaining.GetIndex( d ) );
+      slabs.push_back( slab );
+      }
+    if ( remainingEnd > innerEnd )
+      {
+      OutputImageRegionType slab = remaining;
+      slab.SetIndex( d, innerEnd );
+      slab.SetSize( d, remainingEnd - innerEnd );
+      slabs.push_back( slab );
+      }
+
+    // continue with the part of remaining which matches inner along d
+    remaining.SetIndex( d, inner.GetIndex( d ) );
+    remaining.SetSize( d, inner.GetSize( d ) );
+    }
+}
+
+template< class TInputImage, class TOutputImage, class TKernel >
+void
+SeparableBinaryMorphologyImageFilter< TInputImage, TOutputImage, TKernel >
+::AllocateOutputsNotInPlace()
+{
+  OutputImageType *outputPtr = this->GetOutput();
+
+  OutputImageRegionType bufferedRegion = outputPtr->GetRequestedRegion();
+  bufferedRegion.PadByRadius( this->m_Kernel.GetRadius() );
+  bufferedRegion.Crop( this->GetInput()->GetBufferedRegion() );
+
+  outputPtr->SetBufferedRegion( bufferedRegion );
+  outputPtr->Allocate();
 }
 
 template< class TInputImage, class TOutputImage, class TKernel >
@@ -41,20 +157,32 @@ SeparableBinaryMorphologyImageFilter< TInputImage, TOutputImage, TKernel >
   OutputImageType *outputPtr = this->GetOutput();
 
   const class TOutputImage::SizeType & requestedRegionSize =
-    outputPtr->GetRequestedRegion().GetSize();
+    this->m_PassRegion.GetSize();
 
   int splitAxis;
   typename TOutputImage::IndexType splitIndex;
   typename TOutputImage::SizeType splitSize;
 
-  // Initialize the splitRegion to the output requested region
-  splitRegion = outputPtr->GetRequestedRegion();
+  // Initialize the splitRegion to the region of the current pass
+  splitRegion = this->m_PassRegion;
   splitIndex = splitRegion.GetIndex();
   splitSize = splitRegion.GetSize();
 
   // split on the outermost dimension available
   // and avoid the current dimension
   splitAxis = outputPtr->GetImageDimension() - 1;
+
+  // when NUMA aware, split every pass on the same axis so each
+  // thread works on the same piece of memory it first touched
+  if ( this->m_NUMAAware )
+    {
+    const unsigned int partitionAxis = this->GetNUMAPartitionAxis();
+    if ( requestedRegionSize[partitionAxis] != 1 && partitionAxis != m_Direction )
+      {
+      splitAxis = partitionAxis;
+      }
+    }
+
   while ( requestedRegionSize[splitAxis] == 1 || splitAxis == (int)m_Direction )
     {
     --splitAxis;
@@ -120,6 +248,28 @@ SeparableBinaryMorphologyImageFilter< TInputImage, TOutputImage, TKernel >
   // memory for the filter's outputs
   this->AllocateOutputs();
 
+  // When the output's buffer is larger than the requested region,
+  // the passes modify the pixels around the requested region which
+  // the later passes use as boundary. When running in place these
+  // are saved to be restored, otherwise they are restored from the
+  // input. The requested region itself is never copied.
+  OutputImageType *outputPtr = this->GetOutput();
+  std::vector< OutputImageRegionType > shell;
+  this->SplitOutsideRegion( this->GetPassRegion( 0 ), outputPtr->GetRequestedRegion(), shell );
+
+  std::vector< typename TOutputImage::Pointer > saved;
+  if ( this->GetRunningInPlace() )
+    {
+    for ( size_t i = 0; i < shell.size(); ++i )
+      {
+      typename TOutputImage::Pointer slab = TOutputImage::New();
+      slab->SetRegions( shell[i] );
+      slab->Allocate();
+      ImageAlgorithm::Copy( outputPtr, slab.GetPointer(), shell[i], shell[i] );
+      saved.push_back( slab );
+      }
+    }
+
   // Call a method that can be overridden by a subclass to perform
   // some calculations prior to splitting the main computations into
   // separate threads
@@ -132,10 +282,27 @@ SeparableBinaryMorphologyImageFilter< TInputImage, TOutputImage, TKernel >
   this->GetMultiThreader()->SetNumberOfThreads( this->GetNumberOfThreads() );
   this->GetMultiThreader()->SetSingleMethod(this->ThreaderCallback, &str);
 
+  this->m_ProcessorIds.clear();
+#if defined( __linux__ )
+  cpu_set_t cpuSet;
+  CPU_ZERO(&cpuSet);
+  if ( this->m_NUMAAware && sched_getaffinity( 0, sizeof( cpuSet ), &cpuSet ) == 0 )
+    {
+    for ( unsigned int cpu = 0; cpu < CPU_SETSIZE; ++cpu )
+      {
+      if ( CPU_ISSET(cpu, &cpuSet) )
+        {
+        this->m_ProcessorIds.push_back( cpu );
+        }
+      }
+    }
+#endif
+
   // multithread the execution in each direction
   for ( unsigned int d = 0; d < TOutputImage::ImageDimension; ++d )
     {
     this->m_Direction = d;
+    this->m_PassRegion = this->GetPassRegion( d );
     SizeValueType r = this->m_Kernel.GetRadius( d );
 
     if ( d == 0 || r > 0 )
@@ -144,6 +311,18 @@ SeparableBinaryMorphologyImageFilter< TInputImage, TOutputImage, TKernel >
       }
     }
 
+  for ( size_t i = 0; i < shell.size(); ++i )
+    {
+    if ( this->GetRunningInPlace() )
+      {
+      ImageAlgorithm::Copy( saved[i].GetPointer(), outputPtr, shell[i], shell[i] );
+      }
+    else
+      {
+      ImageAlgorithm::Copy( this->GetInput(), outputPtr, shell[i], shell[i] );
+      }
+    }
+
   // Call a method that can be overridden by a subclass to perform
   // some calculations after all the threads have completed
   this->AfterThreadedGenerateData();
@@ -161,29 +340,49 @@ SeparableBinaryMorphologyImageFilter< TInputImage, TOutputImage, TKernel >
 
   OutputImageRegionType region = outputRegionForThread;
 
-  // the first time through we may need to copy the input image to the output
-  if ( this->m_Direction == 0 && !this->GetRunningInPlace() )
+#if defined( __linux__ )
+  // The thread may be the calling thread or be reused from a pool, so
+  // its affinity is saved to be restored when done.
+  cpu_set_t threadCPUSet;
+  const bool pinned = !this->m_ProcessorIds.empty()
+    && sched_getaffinity( 0, sizeof( threadCPUSet ), &threadCPUSet ) == 0;
+  if ( pinned )
     {
-    typename TInputImage::ConstPointer inputImage( this->GetInput() );
-    ImageAlgorithm::Copy( inputImage.GetPointer(), outputImage.GetPointer(),
-                          outputRegionForThread, outputRegionForThread );
+    this->PinThreadToProcessor( threadId );
     }
+#endif
+
+  const SizeValueType radius = this->m_Kernel.GetRadius( this->m_Direction );
 
+  // the lines are read with a halo of the radius, from the buffered
+  // data surrounding the region, cropped at the edge of the buffer
+  OutputImageRegionType lineRegion = region;
+  lineRegion.SetIndex( this->m_Direction, region.GetIndex( this->m_Direction ) - static_cast< IndexValueType >( radius ) );
+  lineRegion.SetSize( this->m_Direction, region.GetSize( this->m_Direction ) + 2 * radius );
+  lineRegion.Crop( outputImage->GetBufferedRegion() );
 
-  InputConstIteratorType inputIterator(outputImage,  region);
+  InputConstIteratorType inputIterator(outputImage,  lineRegion);
   OutputIteratorType     outputIterator(outputImage, region);
 
   inputIterator.SetDirection(this->m_Direction);
   outputIterator.SetDirection(this->m_Direction);
 
-  const unsigned int ln = region.GetSize()[this->m_Direction];
-
-  const SizeValueType radius = this->m_Kernel.GetRadius( this->m_Direction );
+  const unsigned int ln = lineRegion.GetSize()[this->m_Direction];
+  const unsigned int offset = region.GetIndex( this->m_Direction ) - lineRegion.GetIndex( this->m_Direction );
 
   OutputPixelType *outs = 0;
 
   try
     {
+    // the first time through we may need to copy the input image to
+    // the output, including the halo of the lines
+    if ( this->m_Direction == 0 && !this->GetRunningInPlace() )
+      {
+      typename TInputImage::ConstPointer inputImage( this->GetInput() );
+      ImageAlgorithm::Copy( inputImage.GetPointer(), outputImage.GetPointer(),
+                            lineRegion, lineRegion );
+      }
+
     outs = new OutputPixelType[ln];
 
     inputIterator.GoToBegin();
@@ -212,7 +411,7 @@ SeparableBinaryMorphologyImageFilter< TInputImage, TOutputImage, TKernel >
         }
       this->FilterDataArray(outs, ln, static_cast<unsigned int>( r ) );
 
-      unsigned int j = 0;
+      unsigned int j = offset;
       while ( !outputIterator.IsAtEndOfLine() )
         {
         outputIterator.Set( outs[j++] );
@@ -230,10 +429,22 @@ SeparableBinaryMorphologyImageFilter< TInputImage, TOutputImage, TKernel >
   catch (...)
     {
     delete[] outs;
+#if defined( __linux__ )
+    if ( pinned )
+      {
+      sched_setaffinity( 0, sizeof( threadCPUSet ), &threadCPUSet );
+      }
+#endif
     throw;
     }
 
   delete[] outs;
+#if defined( __linux__ )
+  if ( pinned )
+    {
+    sched_setaffinity( 0, sizeof( threadCPUSet ), &threadCPUSet );
+    }
+#endif
 }
 
 
@@ -246,6 +457,7 @@ SeparableBinaryMorphologyImageFilter< TInputImage, TOutputImage, TKernel >
 {
   Superclass::PrintSelf(os, indent);
   os << indent << "Direction: " << m_Direction << std::endl;
+  os << indent << "NUMAAware: " << ( m_NUMAAware ? "On" : "Off" ) << std::endl;
 }
 } // end namespace itk
 
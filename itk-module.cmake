@@ -16,6 +16,7 @@ itk_module(ITKBinaryMorphologyPerformance
   TEST_DEPENDS
     ITKTestKernel
     ITKMetaIO
+    ITKBinaryMathematicalMorphology
   DESCRIPTION
     "${DOCUMENTATION}"
 )
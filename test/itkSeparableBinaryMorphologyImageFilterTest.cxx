@@ -0,0 +1,216 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkImageDuplicator.h"
+#include "itkImageAlgorithm.h"
+#include "itkSeparableBinaryMorphologyTestHelpers.h"
+
+#include <sstream>
+
+//
+// Functional test of the processing options of the separable binary
+// morphology filters, the results are compared bit for bit against
+// the stock ITK BinaryDilateImageFilter / BinaryErodeImageFilter.
+//
+
+namespace
+{
+
+using namespace SeparableBinaryMorphologyTest;
+
+bool Check( const std::string & name, itk::SizeValueType differences )
+{
+  std::cout << name << ": ";
+  if ( differences != 0 )
+    {
+    std::cout << "FAILED " << differences << " pixels differ" << std::endl;
+    return false;
+    }
+  std::cout << "passed" << std::endl;
+  return true;
+}
+
+
+template< class TImage >
+typename TImage::Pointer
+Duplicate( const TImage *image )
+{
+  typedef itk::ImageDuplicator< TImage > DuplicatorType;
+  typename DuplicatorType::Pointer duplicator = DuplicatorType::New();
+  duplicator->SetInputImage( image );
+  duplicator->Update();
+  return duplicator->GetOutput();
+}
+
+
+// Run the separable filter on the region of interest of the input,
+// and count the pixels of the output's buffer which differ from the
+// stock filter's output inside of the region of interest, or from
+// the input outside of it.
+template< class TImage, class TSeparableFilter >
+itk::SizeValueType
+CountSubRegionDifferences( const TImage *input,
+                           const TImage *stockOutput,
+                           const typename TImage::RegionType & roi,
+                           unsigned int radius,
+                           bool inPlace,
+                           bool numaAware )
+{
+  typename TImage::Pointer expected = Duplicate( input );
+  itk::ImageAlgorithm::Copy( stockOutput, expected.GetPointer(), roi, roi );
+
+  // when running in place the input is overwritten
+  typename TImage::Pointer filterInput = Duplicate( input );
+
+  typename TSeparableFilter::Pointer filter = CreateFilter< TSeparableFilter >( filterInput, radius );
+  filter->SetInPlace( inPlace );
+  filter->SetNUMAAware( numaAware );
+  filter->GetOutput()->SetRequestedRegion( roi );
+  filter->Update();
+
+  const TImage *output = filter->GetOutput();
+  if ( filter->GetInPlace() && filter->CanRunInPlace()
+       && output->GetBufferedRegion() != input->GetBufferedRegion() )
+    {
+    std::cout << "output was reallocated, ";
+    return input->GetBufferedRegion().GetNumberOfPixels();
+    }
+  if ( !output->GetBufferedRegion().IsInside( roi ) )
+    {
+    std::cout << "region of interest is not buffered, ";
+    return roi.GetNumberOfPixels();
+    }
+
+  return CountDifferences( output, expected.GetPointer(), output->GetBufferedRegion() );
+}
+
+
+template< class TImage, class TSeparableFilter, class TStockFilter >
+bool TestFilter( const std::string & name,
+                 unsigned int size,
+                 unsigned int radius,
+                 double density )
+{
+  typename TImage::Pointer input = CreateSyntheticImage< TImage >( size, density );
+
+  typename TStockFilter::Pointer stock = CreateFilter< TStockFilter >( input, radius );
+  stock->SetBoundaryToForeground( TSeparableFilter::New()->GetBoundaryToForeground() );
+  stock->Update();
+  const TImage *expected = stock->GetOutput();
+
+  bool pass = true;
+
+  // the NUMA aware partitioning must not change the result, the
+  // partition only differs from the default with three or more
+  // dimensions. With the default InPlace on, the output must still be
+  // newly allocated, to be first touched by the worker threads.
+  typename TImage::Pointer numaInput = Duplicate( input.GetPointer() );
+  const PixelType *numaInputBuffer = numaInput->GetBufferPointer();
+  typename TSeparableFilter::Pointer numa = CreateFilter< TSeparableFilter >( numaInput, radius );
+  numa->NUMAAwareOn();
+  numa->Update();
+  if ( numa->GetOutput()->GetBufferPointer() == numaInputBuffer )
+    {
+    std::cout << name << " NUMAAware: FAILED ran in place" << std::endl;
+    pass = false;
+    }
+  pass &= Check( name + " NUMAAware",
+                 CountDifferences( numa->GetOutput(), expected, input->GetBufferedRegion() ) );
+
+  // regions of interest in the center, and at the lower and upper
+  // corners where the halo is clipped by the edge of the buffer
+  const typename TImage::RegionType & bufferedRegion = input->GetBufferedRegion();
+  typename TImage::RegionType center = bufferedRegion;
+  typename TImage::RegionType lower = bufferedRegion;
+  typename TImage::RegionType upper = bufferedRegion;
+  for ( unsigned int d = 0; d < TImage::ImageDimension; ++d )
+    {
+    const itk::SizeValueType s = bufferedRegion.GetSize( d );
+    center.SetIndex( d, bufferedRegion.GetIndex( d ) + static_cast< itk::IndexValueType >( s / 4 ) );
+    center.SetSize( d, s / 2 );
+    lower.SetSize( d, s / 3 );
+    upper.SetIndex( d, bufferedRegion.GetIndex( d ) + static_cast< itk::IndexValueType >( s - s / 3 ) );
+    upper.SetSize( d, s / 3 );
+    }
+
+  const typename TImage::RegionType rois[] = { center, lower, upper };
+  const char * roiNames[] = { " center", " lower corner", " upper corner" };
+
+  for ( unsigned int i = 0; i < 3; ++i )
+    {
+    // the result must not depend on running in place
+    pass &= Check( name + roiNames[i] + " sub-region InPlaceOn",
+                   CountSubRegionDifferences< TImage, TSeparableFilter >( input, expected, rois[i], radius, true, false ) );
+    pass &= Check( name + roiNames[i] + " sub-region InPlaceOff",
+                   CountSubRegionDifferences< TImage, TSeparableFilter >( input, expected, rois[i], radius, false, false ) );
+    }
+
+  // NUMAAware does not run in place, also on a sub-region
+  pass &= Check( name + " center sub-region InPlaceOn NUMAAware",
+                 CountSubRegionDifferences< TImage, TSeparableFilter >( input, expected, center, radius, true, true ) );
+
+  return pass;
+}
+
+
+template< unsigned int VDimension >
+bool TestDimension( unsigned int size )
+{
+  typedef typename Types< VDimension >::ImageType           ImageType;
+  typedef typename Types< VDimension >::SeparableDilateType SeparableDilateType;
+  typedef typename Types< VDimension >::SeparableErodeType  SeparableErodeType;
+  typedef typename Types< VDimension >::StockDilateType     StockDilateType;
+  typedef typename Types< VDimension >::StockErodeType      StockErodeType;
+
+  std::ostringstream dimension;
+  dimension << VDimension << "D";
+
+  bool pass = true;
+  pass &= TestFilter< ImageType, SeparableDilateType, StockDilateType >( "Dilate" + dimension.str() + " r2", size, 2, 0.05 );
+  pass &= TestFilter< ImageType, SeparableDilateType, StockDilateType >( "Dilate" + dimension.str() + " r18", size, 18, 0.005 );
+  pass &= TestFilter< ImageType, SeparableErodeType, StockErodeType >( "Erode" + dimension.str() + " r2", size, 2, 0.95 );
+  pass &= TestFilter< ImageType, SeparableErodeType, StockErodeType >( "Erode" + dimension.str() + " r18", size, 18, 0.995 );
+  return pass;
+}
+
+}
+
+
+int itkSeparableBinaryMorphologyImageFilterTest(int, char *[])
+{
+  bool pass = true;
+  try
+    {
+    pass &= TestDimension< 2 >( 200 );
+    pass &= TestDimension< 3 >( 48 );
+    }
+  catch ( itk::ExceptionObject & excp )
+    {
+    std::cerr << excp << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  if ( !pass )
+    {
+    std::cerr << "Test failed!" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  return EXIT_SUCCESS;
+
+}
@@ -0,0 +1,367 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkTimeProbe.h"
+#include "itkSeparableBinaryMorphologyTestHelpers.h"
+#include "itksys/SystemInformation.hxx"
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <map>
+#include <vector>
+
+//
+// Regression test for the separable binary morphology filters.
+//
+// A fixed set of synthetic workloads is run through both the
+// separable filters and the stock ITK BinaryDilateImageFilter /
+// BinaryErodeImageFilter. The results must match bit for bit. The
+// throughput of the separable filter is measured relative to the
+// stock filter on the same machine, in the same run, and compared
+// against the values stored in the baseline file. A workload which is
+// slower than its baseline by more than the tolerance fails the test.
+//
+// Each filter is timed as the median of several samples, each sample
+// repeating the update until it lasts at least a minimum duration.
+// The ratio is only compared when the samples of both filters are
+// stable, otherwise the measurement is repeated a few times before
+// the workload is reported as unstable.
+//
+// The baseline file has one "WorkloadName RelativeThroughput" pair
+// per line, lines starting with '#' are ignored. When an optional
+// output file name is given the measured values are written to it in
+// the same format, with a header describing the machine, so that the
+// baseline can be regenerated.
+//
+// When the baseline file does not exist, or when the timings of a
+// workload are not stable, the results are still checked against the
+// stock filters, but instead of passing the test returns the skip
+// return code. A baseline file which lists no workloads is an error.
+//
+
+namespace
+{
+
+using namespace SeparableBinaryMorphologyTest;
+
+typedef std::map< std::string, double >     BaselineMapType;
+
+const unsigned int  NumberOfSamples = 5;
+const double        MinimumSampleDuration = 0.1;
+const double        MaximumTimingSpread = 0.1;
+const unsigned int  NumberOfMeasurementAttempts = 3;
+const int           SkipReturnCode = 77;
+
+struct Workload
+{
+  const char   *name;
+  bool          dilate;
+  unsigned int  radius;
+  double        density;
+};
+
+// The radii include values larger than 16 to cover the case where
+// the separable kernel is applied multiple times per line.
+const Workload Workloads2D[] =
+{
+  { "Dilate2D_r1_d05",  true,  1,  0.05 },
+  { "Dilate2D_r5_d05",  true,  5,  0.05 },
+  { "Dilate2D_r20_d01", true,  20, 0.01 },
+  { "Erode2D_r1_d95",   false, 1,  0.95 },
+  { "Erode2D_r5_d95",   false, 5,  0.95 },
+  { "Erode2D_r20_d99",  false, 20, 0.99 }
+};
+
+const Workload Workloads3D[] =
+{
+  { "Dilate3D_r1_d05",  true,  1,  0.05 },
+  { "Dilate3D_r3_d01",  true,  3,  0.01 },
+  { "Dilate3D_r18_d001", true,  18, 0.001 },
+  { "Erode3D_r1_d95",   false, 1,  0.95 },
+  { "Erode3D_r3_d99",   false, 3,  0.99 },
+  { "Erode3D_r18_d999", false, 18, 0.999 }
+};
+
+
+bool ReadBaseline( const char *fileName, BaselineMapType & baseline )
+{
+  std::ifstream in( fileName );
+  if ( !in )
+    {
+    return false;
+    }
+
+  std::string line;
+  while ( std::getline( in, line ) )
+    {
+    if ( line.empty() || line[0] == '#' )
+      {
+      continue;
+      }
+    std::istringstream iss( line );
+    std::string        name;
+    double             value;
+    if ( iss >> name >> value )
+      {
+      baseline[name] = value;
+      }
+    }
+  return true;
+}
+
+
+struct Timing
+{
+  /** Median time of an update in seconds. */
+  double median;
+
+  /** Interquartile range of the samples relative to the median. */
+  double spread;
+};
+
+
+// Time a number of updates of the filter, and return the time of an
+// update in seconds.
+double TimeUpdates( itk::ProcessObject *filter, unsigned int numberOfUpdates )
+{
+  itk::TimeProbe probe;
+  probe.Start();
+  for ( unsigned int i = 0; i < numberOfUpdates; ++i )
+    {
+    filter->Modified();
+    filter->Update();
+    }
+  probe.Stop();
+  return static_cast< double >( probe.GetTotal() ) / numberOfUpdates;
+}
+
+
+Timing TimeFilter( itk::ProcessObject *filter )
+{
+  // the first update also warms up the caches and the allocator
+  const double estimate = std::max( TimeUpdates( filter, 1 ), 1e-9 );
+  const unsigned int updatesPerSample =
+    std::max( 1u, static_cast< unsigned int >( vcl_ceil( MinimumSampleDuration / estimate ) ) );
+
+  std::vector< double > samples;
+  for ( unsigned int i = 0; i < NumberOfSamples; ++i )
+    {
+    samples.push_back( TimeUpdates( filter, updatesPerSample ) );
+    }
+  std::sort( samples.begin(), samples.end() );
+
+  Timing timing;
+  timing.median = std::max( samples[NumberOfSamples / 2], 1e-9 );
+  timing.spread = ( samples[3 * NumberOfSamples / 4] - samples[NumberOfSamples / 4] ) / timing.median;
+  return timing;
+}
+
+
+template< class TImage, class TSeparableFilter, class TStockFilter >
+bool RunWorkload( const Workload & workload,
+                  const TImage *input,
+                  const BaselineMapType & baseline,
+                  double tolerance,
+                  std::ostream & measured,
+                  unsigned int & numberOfUnstable )
+{
+  typename TSeparableFilter::Pointer separable = CreateFilter< TSeparableFilter >( input, workload.radius );
+  // the input is reused for every repetition, so it must not be
+  // overwritten
+  separable->InPlaceOff();
+
+  typename TStockFilter::Pointer stock = CreateFilter< TStockFilter >( input, workload.radius );
+  stock->SetBoundaryToForeground( separable->GetBoundaryToForeground() );
+
+  Timing separableTiming;
+  Timing stockTiming;
+  bool   stable = false;
+  for ( unsigned int attempt = 0; attempt < NumberOfMeasurementAttempts && !stable; ++attempt )
+    {
+    separableTiming = TimeFilter( separable );
+    stockTiming = TimeFilter( stock );
+    stable = separableTiming.spread <= MaximumTimingSpread && stockTiming.spread <= MaximumTimingSpread;
+    }
+  const double separableTime = separableTiming.median;
+  const double stockTime = stockTiming.median;
+
+  const itk::SizeValueType numberOfPixels = input->GetBufferedRegion().GetNumberOfPixels();
+  const itk::SizeValueType differences = CountDifferences( separable->GetOutput(), stock->GetOutput(),
+                                                           input->GetBufferedRegion() );
+
+  // relative throughput is the speed up over the stock filter
+  const double relativeThroughput = stockTime / separableTime;
+
+  std::cout << workload.name
+            << "\t" << numberOfPixels / separableTime * 1e-6 << " Mpixel/s"
+            << "\t" << relativeThroughput << "x stock"
+            << "\tspread " << separableTiming.spread << " / " << stockTiming.spread;
+
+  if ( stable )
+    {
+    measured << workload.name << " " << relativeThroughput << std::endl;
+    }
+
+  bool pass = true;
+  if ( differences != 0 )
+    {
+    std::cout << "\tFAILED: " << differences << " pixels differ from stock filter";
+    pass = false;
+    }
+
+  BaselineMapType::const_iterator b = baseline.find( workload.name );
+  if ( !stable )
+    {
+    std::cout << "\tUNSTABLE: throughput not checked";
+    ++numberOfUnstable;
+    }
+  else if ( baseline.empty() )
+    {
+    // no baseline file, only the results are checked
+    }
+  else if ( b == baseline.end() )
+    {
+    std::cout << "\tFAILED: missing from baseline";
+    pass = false;
+    }
+  else if ( relativeThroughput < b->second * ( 1.0 - tolerance ) )
+    {
+    std::cout << "\tFAILED: slower than baseline of " << b->second << "x";
+    pass = false;
+    }
+
+  std::cout << std::endl;
+  return pass;
+}
+
+
+template< unsigned int VDimension, unsigned int VNumberOfWorkloads >
+bool RunWorkloads( const Workload (&workloads)[VNumberOfWorkloads],
+                   unsigned int size,
+                   const BaselineMapType & baseline,
+                   double tolerance,
+                   std::ostream & measured,
+                   unsigned int & numberOfUnstable )
+{
+  typedef typename Types< VDimension >::ImageType           ImageType;
+  typedef typename Types< VDimension >::SeparableDilateType SeparableDilateType;
+  typedef typename Types< VDimension >::SeparableErodeType  SeparableErodeType;
+  typedef typename Types< VDimension >::StockDilateType     StockDilateType;
+  typedef typename Types< VDimension >::StockErodeType      StockErodeType;
+
+  bool pass = true;
+  for ( unsigned int i = 0; i < VNumberOfWorkloads; ++i )
+    {
+    const Workload & workload = workloads[i];
+    typename ImageType::Pointer input = CreateSyntheticImage< ImageType >( size, workload.density );
+
+    if ( workload.dilate )
+      {
+      pass &= RunWorkload< ImageType, SeparableDilateType, StockDilateType >( workload, input, baseline, tolerance, measured, numberOfUnstable );
+      }
+    else
+      {
+      pass &= RunWorkload< ImageType, SeparableErodeType, StockErodeType >( workload, input, baseline, tolerance, measured, numberOfUnstable );
+      }
+    }
+  return pass;
+}
+
+}
+
+
+int itkSeparableBinaryMorphologyPerformanceTest(int argc, char * argv[])
+{
+  if( argc < 3 )
+    {
+    std::cerr << "Missing Parameters " << std::endl;
+    std::cerr << "Usage: " << argv[0];
+    std::cerr << " BaselineFile Tolerance [MeasuredOutputFile]" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  BaselineMapType baseline;
+  const bool haveBaseline = ReadBaseline( argv[1], baseline );
+  if ( !haveBaseline )
+    {
+    std::cout << "No baseline file: " << argv[1] << ", the throughput will not be checked." << std::endl;
+    }
+  else if ( baseline.empty() )
+    {
+    std::cerr << "The baseline file lists no workloads: " << argv[1] << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  const double tolerance = atof( argv[2] );
+
+  itksys::SystemInformation systemInformation;
+  systemInformation.RunCPUCheck();
+  systemInformation.RunOSCheck();
+
+  std::ostringstream measured;
+  measured << "# Workload RelativeThroughput" << std::endl
+           << "#" << std::endl
+           << "# Measured on: " << systemInformation.GetHostname() << std::endl
+           << "# CPU: " << systemInformation.GetExtendedProcessorName()
+           << ", " << systemInformation.GetNumberOfPhysicalCPU() << " physical / "
+           << systemInformation.GetNumberOfLogicalCPU() << " logical processors" << std::endl
+           << "# OS: " << systemInformation.GetOSName() << " " << systemInformation.GetOSRelease() << std::endl;
+
+  // the images are large enough that every pass streams through
+  // memory, rather than running from the cache
+  bool         pass = true;
+  unsigned int numberOfUnstable = 0;
+  try
+    {
+    pass &= RunWorkloads< 2 >( Workloads2D, 2048, baseline, tolerance, measured, numberOfUnstable );
+    pass &= RunWorkloads< 3 >( Workloads3D, 128, baseline, tolerance, measured, numberOfUnstable );
+    }
+  catch ( itk::ExceptionObject & excp )
+    {
+    std::cerr << excp << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  if ( argc > 3 )
+    {
+    std::ofstream out( argv[3] );
+    out << measured.str();
+    }
+
+  if ( !pass )
+    {
+    std::cerr << "Performance regression test failed!" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  if ( !haveBaseline )
+    {
+    return SkipReturnCode;
+    }
+
+  if ( numberOfUnstable != 0 )
+    {
+    std::cout << "The timings of " << numberOfUnstable
+              << " workloads were not stable, their throughput was not checked." << std::endl;
+    return SkipReturnCode;
+    }
+
+  return EXIT_SUCCESS;
+
+}
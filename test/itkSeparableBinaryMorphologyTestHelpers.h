@@ -0,0 +1,126 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef __itkSeparableBinaryMorphologyTestHelpers_h
+#define __itkSeparableBinaryMorphologyTestHelpers_h
+
+#include "itkImageRegionIterator.h"
+#include "itkImageRegionConstIterator.h"
+#include "itkMersenneTwisterRandomVariateGenerator.h"
+#include "itkBinaryDilateImageFilter.h"
+#include "itkBinaryErodeImageFilter.h"
+#include "itkSeparableBinaryDilateImageFilter.h"
+#include "itkSeparableBinaryErodeImageFilter.h"
+
+//
+// Helpers shared by the tests which compare the separable binary
+// morphology filters against the stock ITK BinaryDilateImageFilter /
+// BinaryErodeImageFilter on synthetic images.
+//
+
+namespace SeparableBinaryMorphologyTest
+{
+
+typedef unsigned char PixelType;
+
+const PixelType Foreground = 255;
+const PixelType Background = 0;
+
+/** The image, separable and stock filter types of a dimension. */
+template< unsigned int VDimension >
+struct Types
+{
+  typedef itk::Image< PixelType, VDimension >       ImageType;
+  typedef itk::FlatStructuringElement< VDimension > SRType;
+
+  typedef itk::SeparableBinaryDilateImageFilter< ImageType, ImageType, SRType > SeparableDilateType;
+  typedef itk::SeparableBinaryErodeImageFilter< ImageType, ImageType, SRType >  SeparableErodeType;
+  typedef itk::BinaryDilateImageFilter< ImageType, ImageType, SRType >          StockDilateType;
+  typedef itk::BinaryErodeImageFilter< ImageType, ImageType, SRType >           StockErodeType;
+};
+
+
+/** Create a cube image with randomly placed foreground pixels at the
+ * density. A private generator with a fixed seed is used, so that
+ * every run processes exactly the same data. */
+template< class TImage >
+typename TImage::Pointer
+CreateSyntheticImage( unsigned int size, double density )
+{
+  typedef itk::Statistics::MersenneTwisterRandomVariateGenerator GeneratorType;
+
+  typename TImage::SizeType imageSize;
+  imageSize.Fill( size );
+
+  typename TImage::RegionType region;
+  region.SetSize( imageSize );
+
+  typename TImage::Pointer image = TImage::New();
+  image->SetRegions( region );
+  image->Allocate();
+
+  GeneratorType::Pointer generator = GeneratorType::New();
+  generator->Initialize( 1971 );
+
+  itk::ImageRegionIterator< TImage > it( image, region );
+  for ( it.GoToBegin(); !it.IsAtEnd(); ++it )
+    {
+    it.Set( generator->GetUniformVariate( 0.0, 1.0 ) < density ? Foreground : Background );
+    }
+
+  return image;
+}
+
+
+/** Count the pixels of region which differ between the images. */
+template< class TImage >
+itk::SizeValueType
+CountDifferences( const TImage *image1, const TImage *image2,
+                  const typename TImage::RegionType & region )
+{
+  itk::ImageRegionConstIterator< TImage > it1( image1, region );
+  itk::ImageRegionConstIterator< TImage > it2( image2, region );
+
+  itk::SizeValueType count = 0;
+  for ( it1.GoToBegin(), it2.GoToBegin(); !it1.IsAtEnd(); ++it1, ++it2 )
+    {
+    if ( it1.Get() != it2.Get() )
+      {
+      ++count;
+      }
+    }
+  return count;
+}
+
+
+/** Create a filter with the radius and the test's foreground and
+ * background values. */
+template< class TFilter >
+typename TFilter::Pointer
+CreateFilter( const typename TFilter::InputImageType *input, unsigned int radius )
+{
+  typename TFilter::Pointer filter = TFilter::New();
+  filter->SetInput( input );
+  filter->SetRadius( radius );
+  filter->SetForegroundValue( Foreground );
+  filter->SetBackgroundValue( Background );
+  return filter;
+}
+
+} // end namespace SeparableBinaryMorphologyTest
+
+#endif